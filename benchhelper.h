@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <functional>
+#include <string>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+const int BENCH_REPEAT = 5;
+
+namespace bench_helper {
+  // Results are folded in here so the compiler cannot drop the measured work.
+  volatile std::size_t sink = 0;
+
+  void init() {
+    std::srand(std::time(NULL));
+  }
+
+  std::string build_text(std::size_t len, const char *alphabet) {
+    std::string ret(len, '\0');
+    std::size_t alphabet_size = std::strlen(alphabet);
+    for (std::size_t i = 0; i < len; ++i) {
+      ret[i] = alphabet[std::rand() % alphabet_size];
+    }
+    return ret;
+  }
+
+  // Random words of 1..16 letters separated by single spaces.
+  std::string build_words(std::size_t len) {
+    std::string ret = build_text(len, "abcdefghijklmnopqrstuvwxyz");
+    for (std::size_t i = std::rand() % 16 + 1; i < len; i += std::rand() % 16 + 2) {
+      ret[i] = ' ';
+    }
+    return ret;
+  }
+
+  // Random words grouped into lines of roughly 40 to 120 chars, each ending with '\n'.
+  std::string build_lines(std::size_t len) {
+    std::string ret = build_words(len);
+    for (std::size_t i = std::rand() % 80 + 40; i < len; i += std::rand() % 80 + 40) {
+      ret[i] = '\n';
+    }
+    ret[len - 1] = '\n';
+    return ret;
+  }
+
+#ifndef _WIN32
+  // Empty file in the current directory, so it is on local disk rather than
+  // a tmpfs. It is unlinked right away and disappears on close().
+  int open_temp_file() {
+    char path[] = "benchmark_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+      std::printf("*** Cannot create temporary file ***\n");
+      std::exit(1);
+    }
+    unlink(path);
+    return fd;
+  }
+
+  // Empties `fd` and rewinds it.
+  void truncate_file(int fd) {
+    if (ftruncate(fd, 0) != 0) {
+      std::printf("*** Cannot truncate temporary file ***\n");
+      std::exit(1);
+    }
+    lseek(fd, 0, SEEK_SET);
+  }
+
+  // Replaces the contents of `fd` with `data` and rewinds it.
+  void write_file(int fd, const std::string &data) {
+    truncate_file(fd);
+    for (std::size_t done = 0; done < data.size(); ) {
+      ssize_t ret = write(fd, data.data() + done, data.size() - done);
+      if (ret <= 0) {
+        std::printf("*** Cannot write temporary file ***\n");
+        std::exit(1);
+      }
+      done += ret;
+    }
+    lseek(fd, 0, SEEK_SET);
+  }
+#endif
+
+  // Runs `func` BENCH_REPEAT times and reports the best run. `bytes` is the
+  // amount of data one run processes and is only used for the MB/s column.
+  double run_bench(const char *name, std::size_t bytes, const std::function<std::size_t(void)> func) {
+    double best = 0;
+    for (int i = 0; i < BENCH_REPEAT; ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      sink += func();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (i == 0 || elapsed.count() < best) {
+        best = elapsed.count();
+      }
+    }
+    printf("%-40s %10.3f ms %10.1f MB/s\n", name, best * 1e3, bytes / best / 1e6);
+    return best;
+  }
+
+}
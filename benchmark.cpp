@@ -0,0 +1,266 @@
+/*
+
+Usage:
+
+Put your declaration and implementation of MyString in `mystring.h`
+and compile & run this file with optimizations enabled.
+
+For example, in Linux: g++ -std=c++14 -O2 benchmark.cpp -o benchmark && ./benchmark
+
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include "mystring.h"
+#include "benchhelper.h"
+
+// Every section of this benchmark covers an optional extension. Define these
+// macros in `mystring.h` (or with -D) for the ones your MyString implements.
+// All extensions after substr() build on it.
+#if (defined(MYSTRING_HAS_SEARCH) || defined(MYSTRING_HAS_STREAM_IO) || defined(MYSTRING_HAS_SERIALIZATION)) && !defined(MYSTRING_HAS_SUBSTR)
+#error "MYSTRING_HAS_SEARCH, MYSTRING_HAS_STREAM_IO and MYSTRING_HAS_SERIALIZATION require MYSTRING_HAS_SUBSTR"
+#endif
+
+using std::printf;
+using namespace bench_helper;
+
+const std::size_t TEXT_SIZE = 16 << 20;
+const std::size_t FILE_SIZE = 64 << 20;
+
+int main() {
+  init();
+
+#ifdef MYSTRING_HAS_SUBSTR
+  printf("===== Benchmarking Substring =====\n");
+
+  {
+    const std::string text = build_words(TEXT_SIZE);
+    const MyString s(text.c_str());
+
+    run_bench("tokenize with substr views", TEXT_SIZE, [&s] {
+      std::vector<MyString> tokens;
+      for (std::size_t start = 0, i = 0; i <= s.size(); ++i) {
+        if (i == s.size() || s[i] == ' ') {
+          tokens.push_back(s.substr(start, i - start));
+          start = i + 1;
+        }
+      }
+      return tokens.size();
+    });
+
+    run_bench("tokenize with copies", TEXT_SIZE, [&s] {
+      std::vector<MyString> tokens;
+      std::vector<char> buffer;
+      for (std::size_t i = 0; i <= s.size(); ++i) {
+        if (i == s.size() || s[i] == ' ') {
+          buffer.push_back('\0');
+          tokens.push_back(MyString(buffer.data()));
+          buffer.clear();
+        } else {
+          buffer.push_back(s[i]);
+        }
+      }
+      return tokens.size();
+    });
+  }
+#endif
+
+#ifdef MYSTRING_HAS_SEARCH
+  printf("===== Benchmarking Search =====\n");
+
+  for (std::size_t size : { std::size_t(64), std::size_t(4) << 10, std::size_t(1) << 20, TEXT_SIZE }) {
+    const std::string text = build_text(size, "abcdefghijklmnopqrstuvwxyz");
+    const MyString s(text.c_str());
+    const std::size_t rounds = TEXT_SIZE / size;
+    char name[64];
+
+    printf("----- haystack %zu bytes -----\n", size);
+    run_bench("MyString.find(char) miss", size * rounds, [&s, rounds] {
+      std::size_t ret = 0;
+      for (std::size_t i = 0; i < rounds; ++i) ret += s.find('\0');
+      return ret;
+    });
+    run_bench("std::string.find(char) miss", size * rounds, [&text, rounds] {
+      std::size_t ret = 0;
+      for (std::size_t i = 0; i < rounds; ++i) ret += text.find('\0');
+      return ret;
+    });
+    run_bench("operator[] loop miss", size * rounds, [&s, rounds] {
+      std::size_t ret = 0;
+      for (std::size_t i = 0; i < rounds; ++i) {
+        std::size_t pos = 0;
+        while (pos < s.size() && s[pos] != '\0') ++pos;
+        ret += pos;
+      }
+      return ret;
+    });
+    run_bench("MyString.rfind(char) miss", size * rounds, [&s, rounds] {
+      std::size_t ret = 0;
+      for (std::size_t i = 0; i < rounds; ++i) ret += s.rfind('\0');
+      return ret;
+    });
+    run_bench("MyString.count(char)", size * rounds, [&s, rounds] {
+      std::size_t ret = 0;
+      for (std::size_t i = 0; i < rounds; ++i) ret += s.count('e');
+      return ret;
+    });
+
+    for (std::size_t needle_len : { 2, 4, 8, 16, 64, 256 }) {
+      if (needle_len > size) continue;
+      // The haystacks are drawn from 'a'..'y' and each needle holds the only
+      // 'z', so it occurs just where it is planted: at the far end for find()
+      // and at the start for rfind(). Every search scans the whole haystack.
+      const std::string body = build_text(size - needle_len, "abcdefghijklmnopqrstuvwxy");
+      const std::string needle = "z" + build_text(needle_len - 1, "abcdefghijklmnopqrstuvwxy");
+      const std::string r_needle = build_text(needle_len - 1, "abcdefghijklmnopqrstuvwxy") + "z";
+      const std::string f_text = body + needle;
+      const MyString f_s(f_text.c_str());
+      const MyString r_s((r_needle + body).c_str());
+      const MyString n(needle.c_str());
+      const MyString r(r_needle.c_str());
+      std::snprintf(name, sizeof(name), "MyString.find(MyString) len %zu", needle_len);
+      run_bench(name, size * rounds, [&f_s, &n, rounds] {
+        std::size_t ret = 0;
+        for (std::size_t i = 0; i < rounds; ++i) ret += f_s.find(n);
+        return ret;
+      });
+      std::snprintf(name, sizeof(name), "std::string.find(string) len %zu", needle_len);
+      run_bench(name, size * rounds, [&f_text, &needle, rounds] {
+        std::size_t ret = 0;
+        for (std::size_t i = 0; i < rounds; ++i) ret += f_text.find(needle);
+        return ret;
+      });
+      std::snprintf(name, sizeof(name), "MyString.rfind(MyString) len %zu", needle_len);
+      run_bench(name, size * rounds, [&r_s, &r, rounds] {
+        std::size_t ret = 0;
+        for (std::size_t i = 0; i < rounds; ++i) ret += r_s.rfind(r);
+        return ret;
+      });
+    }
+  }
+#endif
+
+#if defined(MYSTRING_HAS_STREAM_IO) && !defined(_WIN32)
+  printf("===== Benchmarking Stream I/O =====\n");
+
+  {
+    const std::string text = build_lines(FILE_SIZE);
+    int in_fd = open_temp_file();
+    int out_fd = open_temp_file();
+    write_file(in_fd, text);
+    std::vector<MyString> lines;
+
+    run_bench("fgets + MyString(const char *)", FILE_SIZE, [in_fd] {
+      std::vector<MyString> lines;
+      std::vector<char> buffer(4096);
+      lseek(in_fd, 0, SEEK_SET);
+      FILE *in = fdopen(dup(in_fd), "r");
+      while (std::fgets(buffer.data(), buffer.size(), in)) {
+        lines.push_back(MyString(buffer.data()));
+      }
+      std::fclose(in);
+      return lines.size();
+    });
+
+    run_bench("MyString.read_from(int) + substr", FILE_SIZE, [in_fd, &lines] {
+      lines.clear();
+      lseek(in_fd, 0, SEEK_SET);
+      MyString s;
+      s.read_from(in_fd);
+      // Read through a const reference, or operator[] would unshare the buffer from the lines.
+      const MyString &cs = s;
+      for (std::size_t start = 0, i = 0; i < cs.size(); ++i) {
+        if (cs[i] == '\n') {
+          lines.push_back(cs.substr(start, i + 1 - start));
+          start = i + 1;
+        }
+      }
+      return lines.size();
+    });
+
+    run_bench("printf(\"%s\")", FILE_SIZE, [out_fd, &lines] {
+      truncate_file(out_fd);
+      FILE *out = fdopen(dup(out_fd), "w");
+      std::vector<char> buffer;
+      for (const MyString &line : lines) {
+        buffer.clear();
+        for (std::size_t i = 0; i < line.size(); ++i) {
+          buffer.push_back(line[i]);
+        }
+        buffer.push_back('\0');
+        std::fprintf(out, "%s", buffer.data());
+      }
+      std::fclose(out);
+      return lines.size();
+    });
+
+    run_bench("MyString::write_to(int, ...)", FILE_SIZE, [out_fd, &lines] {
+      truncate_file(out_fd);
+      std::vector<const MyString *> list;
+      for (const MyString &line : lines) {
+        list.push_back(&line);
+      }
+      return MyString::write_to(out_fd, list.data(), list.size());
+    });
+
+    close(in_fd);
+    close(out_fd);
+  }
+#endif
+
+#if defined(MYSTRING_HAS_SERIALIZATION) && !defined(_WIN32)
+  printf("===== Benchmarking Serialization =====\n");
+
+  {
+    // 1000 distinct 4 KB buffers, each shared by 50 copies and 50 substrings.
+    const std::size_t buffers = 1000;
+    const std::size_t buffer_size = 4 << 10;
+    std::vector<MyString> strs;
+    std::size_t logical_size = 0;
+    for (std::size_t b = 0; b < buffers; ++b) {
+      const MyString base(build_text(buffer_size, "abcdefghijklmnopqrstuvwxyz").c_str());
+      for (std::size_t i = 0; i < 100; ++i) {
+        strs.push_back(i % 2 ? base : base.substr(i * 20, buffer_size / 2));
+        logical_size += strs.back().size();
+      }
+    }
+    std::vector<const MyString *> list;
+    for (const MyString &str : strs) {
+      list.push_back(&str);
+    }
+    std::vector<MyString> loaded(strs.size());
+    std::vector<MyString *> loaded_list;
+    for (MyString &str : loaded) {
+      loaded_list.push_back(&str);
+    }
+    int fd = open_temp_file();
+
+    run_bench("MyString::write_to(int, ...) full copies", logical_size, [fd, &list] {
+      truncate_file(fd);
+      return MyString::write_to(fd, list.data(), list.size());
+    });
+    const std::size_t full_size = lseek(fd, 0, SEEK_END);
+
+    run_bench("MyString::save(int, ...)", logical_size, [fd, &list] {
+      truncate_file(fd);
+      return std::size_t(MyString::save(fd, list.data(), list.size()));
+    });
+    const std::size_t saved_size = lseek(fd, 0, SEEK_END);
+
+    run_bench("MyString::load(int, ...)", logical_size, [fd, &loaded_list] {
+      lseek(fd, 0, SEEK_SET);
+      return std::size_t(MyString::load(fd, loaded_list.data(), loaded_list.size()));
+    });
+
+    printf("%zu strings, %.1f MB of text in %zu buffers\n", strs.size(), logical_size / 1e6, buffers);
+    printf("on disk: %.1f MB as full copies, %.1f MB as a snapshot\n", full_size / 1e6, saved_size / 1e6);
+    close(fd);
+  }
+#endif
+
+  return 0;
+}
@@ -5,16 +5,29 @@ Usage:
 Put your declaration and implementation of MyString in `mystring.h`
 and compile & run this file with modern C++ features enabled.
 
-For example, in Linux: g++ -std=c++14 tester.cpp -o tester && ./tester
+For example, in Linux: g++ -std=c++14 -pthread tester.cpp -o tester && ./tester
 
  */
 
 #include <cstdio>
 #include <cassert>
 #include <cstring>
+#include <string>
+#include <algorithm>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 #include "mystring.h"
 #include "testhelper.h"
 
+// The sections after the assignment's original tests cover optional
+// extensions. Define these macros in `mystring.h` (or with -D) for the ones
+// your MyString implements. All extensions after substr() build on it.
+#if (defined(MYSTRING_HAS_SEARCH) || defined(MYSTRING_HAS_STREAM_IO) || defined(MYSTRING_HAS_SERIALIZATION)) && !defined(MYSTRING_HAS_SUBSTR)
+#error "MYSTRING_HAS_SEARCH, MYSTRING_HAS_STREAM_IO and MYSTRING_HAS_SERIALIZATION require MYSTRING_HAS_SUBSTR"
+#endif
+
 using std::printf;
 using namespace test_helper;
 
@@ -255,96 +268,7 @@ int main() {
 
   run_test([] {
     {
-      MyString *s1 = new MyString("abcde");
-      MyString *s2 = new MyString("abcde");
-      test_assert(__LINE__,  (*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__, !(*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcde");
-      MyString *s2 = new MyString("abcdef");
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__, !(*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__,  (*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcdefg");
-      MyString *s2 = new MyString("abcdef");
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("aacdefg");
-      MyString *s2 = new MyString("abcdef");
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__, !(*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__,  (*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcdeg");
-      MyString *s2 = new MyString("abcdef");
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcdegabc");
-      MyString *s2 = new MyString("abcdefabc");
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
+      test_all_comparisons<MyString, 4, 'a', 'b', 'c'>(__LINE__, 1);
     }
     test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
   });
@@ -399,32 +323,7 @@ int main() {
 
   run_test([] {
     {
-      MyString *s1 = new MyString("");
-      MyString *s2 = new MyString("");
-      test_assert(__LINE__,  (*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__, !(*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("a");
-      MyString *s2 = new MyString("");
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
+      test_all_comparisons<MyString, 3, 'a'>(__LINE__, 1);
     }
     test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
   });
@@ -487,108 +386,14 @@ int main() {
 
   run_test([] {
     {
-      MyString *s1 = new MyString("abcde");
-      MyString *s2 = new MyString("abcde");
-      (*s1)[3] = '\0';
-      (*s2)[3] = '\0';
-      test_assert(__LINE__,  (*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__, !(*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcde");
-      MyString *s2 = new MyString("abcdef");
-      (*s1)[3] = '\0';
-      (*s2)[3] = '\0';
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__, !(*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__,  (*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcdefg");
-      MyString *s2 = new MyString("abcdef");
-      (*s1)[3] = '\0';
-      (*s2)[3] = '\0';
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("aacdefg");
-      MyString *s2 = new MyString("abcdef");
-      (*s1)[0] = '\0';
-      (*s2)[0] = '\0';
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__, !(*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__,  (*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__, !(*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__,  (*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
+      test_all_comparisons<MyString, 3, '\0', 'a', 'b'>(__LINE__, 1);
     }
     test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
   });
 
   run_test([] {
     {
-      MyString *s1 = new MyString("abcdeg");
-      MyString *s2 = new MyString("abcdef");
-      (*s1)[3] = '\0';
-      (*s2)[3] = '\0';
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
-    }
-    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
-  });
-
-  run_test([] {
-    {
-      MyString *s1 = new MyString("abcdegabc");
-      MyString *s2 = new MyString("abcdefabc");
-      (*s1)[3] = '\0';
-      (*s2)[3] = '\0';
-      test_assert(__LINE__, !(*s1 == *s2), "MyString.operator== incorrect");
-      test_assert(__LINE__,  (*s1 >= *s2), "MyString.operator>= incorrect");
-      test_assert(__LINE__, !(*s1 <= *s2), "MyString.operator<= incorrect");
-      test_assert(__LINE__,  (*s1 != *s2), "MyString.operator!= incorrect");
-      test_assert(__LINE__,  (*s1 >  *s2), "MyString.operator> incorrect");
-      test_assert(__LINE__, !(*s1 <  *s2), "MyString.operator< incorrect");
-      delete s1;
-      delete s2;
+      test_all_comparisons<MyString, 7, '\0', 'a', 'b'>(__LINE__, 0);
     }
     test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
   });
@@ -663,6 +468,603 @@ int main() {
     test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
   });
 
+#ifdef MYSTRING_HAS_SUBSTR
+  printf("===== Testing Substring =====\n");
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      const MyString *s = new MyString(str.get());
+      for (int skip = 0, pos = 0; pos <= len && !skip; pos += 97) {
+        MyString *v = new MyString(s->substr(pos, 50));
+        int len_v = pos + 50 <= len ? 50 : len - pos;
+        test_assert(__LINE__, v->size() == len_v, "MyString.substr(size_t, size_t) should clamp the length to the end of the string") || (skip = 1, false);
+        for (int i = 0; i < len_v && !skip; ++i) {
+          test_assert(__LINE__, (*v)[i] == str[pos + i], "MyString.substr(size_t, size_t) should return the characters in range") || (skip = 1, false);
+        }
+        delete v;
+      }
+      delete s;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s = new MyString(str.get());
+      MyString *v1 = new MyString(s->substr(0, 0));
+      MyString *v2 = new MyString(s->substr(len, 10));
+      MyString *v3 = new MyString(s->substr(0, len));
+      test_assert(__LINE__, v1->size() == 0, "MyString.substr(size_t, size_t) incorrect for empty range");
+      test_assert(__LINE__, v2->size() == 0, "MyString.substr(size_t, size_t) incorrect at the end of the string");
+      test_assert(__LINE__, *v3 == *s, "MyString.substr(size_t, size_t) incorrect for the whole string");
+      v1->append("abc");
+      test_assert(__LINE__, v1->size() == 3 && (*v1)[0] == 'a' && (*v1)[2] == 'c', "MyString.append(const char *) incorrect on an empty substring");
+      test_assert(__LINE__, s->size() == len, "Appending to a substring should not mutate its parent");
+      delete v1;
+      delete v2;
+      delete v3;
+      delete s;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s = new MyString(str.get());
+      int last_alloc_mem = alloc_mem;
+      int last_alloc_times = alloc_times;
+      MyString *v1 = new MyString(s->substr(len / 2, len / 2));
+      MyString *v2 = new MyString(v1->substr(10, 100));
+      // the only allocations are the two MyString objects themselves.
+      test_assert(__LINE__, alloc_times - last_alloc_times == 2, "MyString.substr(size_t, size_t) should not allocate a buffer");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX * 2, "MyString.substr(size_t, size_t) should share the buffer of its parent");
+      test_assert(__LINE__, v2->size() == 100, "MyString.substr(size_t, size_t) of a substring incorrect");
+      for (int skip = 0, i = 0; i < 100 && !skip; ++i) {
+        test_assert(__LINE__, (*v2)[i] == str[len / 2 + 10 + i], "MyString.substr(size_t, size_t) of a substring incorrect") || (skip = 1, false);
+      }
+      delete v1;
+      delete v2;
+      delete s;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s = new MyString(str.get());
+      (*s)[len / 3] = '\0';
+      int last_alloc_mem = alloc_mem;
+      int last_alloc_times = alloc_times;
+      MyString *v = new MyString(s->substr(len / 3 - 100, 200));
+      test_assert(__LINE__, alloc_times - last_alloc_times == 1, "MyString.substr(size_t, size_t) should not allocate a buffer");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX, "MyString.substr(size_t, size_t) should share the buffer of its parent");
+      test_assert(__LINE__, v->size() == 200, "MyString.substr(size_t, size_t) incorrect when there are null chars");
+      test_assert(__LINE__, (*v)[100] == '\0' && (*v)[101] == str[len / 3 + 1], "MyString.substr(size_t, size_t) incorrect when there are null chars");
+
+      (*v)[0]++;
+      // mutate the substring. only its 200 chars are copied out.
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX * 2 + 200, "Mutating a substring should only copy the substring");
+      test_assert(__LINE__, (*v)[0] == str[len / 3 - 100] + 1, "MyString[size_t] should be mutable on a substring");
+      test_assert(__LINE__, (*s)[len / 3 - 100] == str[len / 3 - 100], "Mutating a substring should not mutate its parent");
+      delete v;
+      delete s;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s = new MyString(str.get());
+      MyString *v = new MyString(s->substr(1, 10));
+      int last_alloc_mem = alloc_mem;
+
+      (*s)[1]++;
+      // mutate the parent. the substring keeps the original buffer alive.
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX + len, "Mutating the parent of a substring should only copy the parent");
+      test_assert(__LINE__, (*s)[1] == str[1] + 1, "MyString[size_t] should be mutable");
+      test_assert(__LINE__, (*v)[0] == str[1], "Mutating the parent of a substring should not mutate the substring");
+
+      delete s;
+      for (int skip = 0, i = 0; i < 10 && !skip; ++i) {
+        test_assert(__LINE__, (*v)[i] == str[1 + i], "A substring should outlive its parent") || (skip = 1, false);
+      }
+      delete v;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s = new MyString(str.get());
+      MyString *v = new MyString(s->substr(len - 20, 20));
+      v->append(*s);
+      test_assert(__LINE__, v->size() == 20 + len, "MyString.append(MyString) should update \'.size()\' on a substring");
+      test_assert(__LINE__, s->size() == len, "Appending to a substring should not mutate its parent");
+      for (int skip = 0, i = 0; i < 20 + len && !skip; ++i) {
+        test_assert(__LINE__, (*v)[i] == str[i < 20 ? len - 20 + i : i - 20], "MyString.append(MyString) incorrect on a substring") || (skip = 1, false);
+      }
+      delete v;
+      delete s;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      const MyString *s = new MyString(str.get());
+      int last_alloc_mem = alloc_mem;
+      int last_alloc_times = alloc_times;
+      MyString **tokens = new MyString*[len / 100];
+      for (int i = 0; i < len / 100; ++i) {
+        tokens[i] = new MyString(s->substr(i * 100, 100));
+      }
+      test_assert(__LINE__, alloc_times - last_alloc_times == len / 100 + 1, "Slicing a MyString into substrings should not allocate buffers");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX * (len / 100 + 1), "Slicing a MyString into substrings should not copy the string");
+      for (int skip = 0, i = 0; i < len / 100 && !skip; ++i) {
+        test_assert(__LINE__, *tokens[i] == s->substr(i * 100, 100), "MyString.substr(size_t, size_t) should compare equal to itself") || (skip = 1, false);
+        test_assert(__LINE__, (*tokens[i])[99] == str[i * 100 + 99], "MyString.substr(size_t, size_t) should return the characters in range") || (skip = 1, false);
+      }
+      for (int i = 0; i < len / 100; ++i) {
+        delete tokens[i];
+      }
+      delete[] tokens;
+      delete s;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+#endif
+
+#ifdef MYSTRING_HAS_SEARCH
+  printf("===== Testing Search =====\n");
+
+  run_test([] {
+    {
+      for (int skip = 0, len = 0; len <= 300 && !skip; ++len) {
+        const std::string str = build_random_string<'\0', 'a', 'b', 'c'>(len);
+        const auto s = build_string<MyString>(str);
+        const MyString &cs = *s;
+        for (char c : { '\0', 'a', 'b', 'c', 'd' }) {
+          test_assert(__LINE__, cs.find(c) == str.find(c), "MyString.find(char) incorrect") || (skip = 1, false);
+          test_assert(__LINE__, cs.rfind(c) == str.rfind(c), "MyString.rfind(char) incorrect") || (skip = 1, false);
+          test_assert(__LINE__, cs.count(c) == std::count(str.begin(), str.end(), c), "MyString.count(char) incorrect") || (skip = 1, false);
+        }
+      }
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      for (int skip = 0, round = 0; round < 2000 && !skip; ++round) {
+        const std::string str = build_random_string<'\0', 'a', 'b'>(std::rand() % 400);
+        std::string needle;
+        if (round % 2 == 0 && str.size() > 0) {
+          std::size_t pos = std::rand() % str.size();
+          needle = str.substr(pos, std::rand() % 40 + 1);
+        } else {
+          needle = build_random_string<'\0', 'a', 'b'>(std::rand() % 12 + 1);
+        }
+        const auto s = build_string<MyString>(str);
+        const auto n = build_string<MyString>(needle);
+        test_assert(__LINE__, s->find(*n) == str.find(needle), "MyString.find(MyString) incorrect") || (skip = 1, false);
+        test_assert(__LINE__, s->rfind(*n) == str.rfind(needle), "MyString.rfind(MyString) incorrect") || (skip = 1, false);
+        test_assert(__LINE__, s->count(*n) == count_occurrences(str, needle), "MyString.count(MyString) incorrect") || (skip = 1, false);
+      }
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const std::string str = build_random_string<'\0', 'a', 'b', 'c'>(300);
+      const std::string needle = str.substr(250, 20);
+      const auto s = build_string<MyString>(str);
+      const auto n = build_string<MyString>(needle);
+      for (int skip = 0, pos = 0; pos < 64 && !skip; ++pos) {
+        const std::string ref = str.substr(pos, 200 + pos % 7);
+        const MyString v = s->substr(pos, 200 + pos % 7);
+        for (char c : { '\0', 'a', 'd' }) {
+          test_assert(__LINE__, v.find(c) == ref.find(c), "MyString.find(char) incorrect on a substring") || (skip = 1, false);
+          test_assert(__LINE__, v.rfind(c) == ref.rfind(c), "MyString.rfind(char) incorrect on a substring") || (skip = 1, false);
+          test_assert(__LINE__, v.count(c) == std::count(ref.begin(), ref.end(), c), "MyString.count(char) incorrect on a substring") || (skip = 1, false);
+        }
+        const MyString w = n->substr(0, 1 + pos % 20);
+        const std::string w_ref = needle.substr(0, 1 + pos % 20);
+        test_assert(__LINE__, v.find(w) == ref.find(w_ref), "MyString.find(MyString) incorrect on a substring") || (skip = 1, false);
+        test_assert(__LINE__, v.rfind(w) == ref.rfind(w_ref), "MyString.rfind(MyString) incorrect on a substring") || (skip = 1, false);
+      }
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      MyString *s1 = new MyString("");
+      MyString *s2 = new MyString("");
+      MyString *s3 = new MyString("abc");
+      MyString *s4 = new MyString("abcd");
+      test_assert(__LINE__, s1->find('a') == std::string::npos, "MyString.find(char) should return npos on an empty string");
+      test_assert(__LINE__, s1->rfind('\0') == std::string::npos, "MyString.rfind(char) should return npos on an empty string");
+      test_assert(__LINE__, s1->count('\0') == 0, "MyString.count(char) should return zero on an empty string");
+      test_assert(__LINE__, s1->find(*s2) == 0, "MyString.find(MyString) should find an empty string at position 0");
+      test_assert(__LINE__, s3->find(*s2) == 0, "MyString.find(MyString) should find an empty string at position 0");
+      test_assert(__LINE__, s3->rfind(*s2) == 3, "MyString.rfind(MyString) should find an empty string at the end");
+      test_assert(__LINE__, s1->count(*s2) == 1, "MyString.count(MyString) should count an empty string once more than the length");
+      test_assert(__LINE__, s3->count(*s2) == 4, "MyString.count(MyString) should count an empty string once more than the length");
+      test_assert(__LINE__, s3->find(*s4) == std::string::npos, "MyString.find(MyString) should return npos for a longer needle");
+      test_assert(__LINE__, s3->rfind(*s4) == std::string::npos, "MyString.rfind(MyString) should return npos for a longer needle");
+      test_assert(__LINE__, s3->count(*s4) == 0, "MyString.count(MyString) should return zero for a longer needle");
+      test_assert(__LINE__, s4->find(*s3) == 0 && s4->rfind(*s3) == 0 && s4->count(*s3) == 1, "MyString search incorrect for a prefix");
+      delete s1;
+      delete s2;
+      delete s3;
+      delete s4;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s1 = new MyString(str.get());
+      MyString *n = new MyString(s1->substr(len - 8, 8));
+      (*s1)[len / 2] = '\0';
+      MyString *s2 = new MyString(*s1);
+      std::string ref(str.get(), len);
+      ref[len / 2] = '\0';
+      const std::string needle = ref.substr(len - 8);
+      int last_alloc_mem = alloc_mem;
+      test_assert(__LINE__, s2->find('\0') == len / 2, "MyString.find(char) should find null chars");
+      test_assert(__LINE__, s2->rfind('\0') == len / 2, "MyString.rfind(char) should find null chars");
+      test_assert(__LINE__, s2->count('\0') == 1, "MyString.count(char) should count null chars");
+      test_assert(__LINE__, s2->rfind(*n) == ref.rfind(needle), "MyString.rfind(MyString) should search past null chars");
+      test_assert(__LINE__, s2->find(*n) == ref.find(needle), "MyString.find(MyString) should search past null chars");
+      test_assert(__LINE__, s2->count(*n) == count_occurrences(ref, needle), "MyString.count(MyString) should search past null chars");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem == 0, "Searching in MyString should not allocate memory or unshare its buffer");
+      delete s1;
+      delete s2;
+      delete n;
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+#endif
+
+#if defined(MYSTRING_HAS_STREAM_IO) && !defined(_WIN32)
+  printf("===== Testing Stream I/O =====\n");
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const std::string str = build_random_string<'\0', 'a', 'b', 'c'>(300000);
+      write_file(fd, str);
+      int last_alloc_mem = alloc_mem;
+      int last_alloc_times = alloc_times;
+      MyString *s = new MyString;
+      test_assert(__LINE__, s->read_from(fd) == str.size(), "MyString.read_from(int) should return the number of bytes read");
+      test_assert(__LINE__, s->size() == str.size(), "MyString.read_from(int) should update \'.size()\'");
+      // a growable buffer may keep up to as much spare capacity as it holds data.
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX + str.size() * 2, "MyString.read_from(int) should read into its own buffer");
+      test_assert(__LINE__, alloc_times - last_alloc_times < 40, "MyString.read_from(int) should grow its buffer geometrically");
+      for (int skip = 0, i = 0; i < str.size() && !skip; ++i) {
+        test_assert(__LINE__, (*s)[i] == str[i], "MyString.read_from(int) should keep null chars") || (skip = 1, false);
+      }
+      test_assert(__LINE__, s->read_from(fd) == 0, "MyString.read_from(int) should return zero at end of file");
+      test_assert(__LINE__, s->size() == str.size(), "MyString.read_from(int) should not change \'.size()\' at end of file");
+      delete s;
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      const std::string data = build_random_string<'\0', 'x'>(5000);
+      write_file(fd, data);
+      MyString *s1 = new MyString(str.get());
+      MyString *s2 = new MyString(*s1);
+      MyString *v = new MyString(s1->substr(0, 10));
+      s1->read_from(fd);
+      test_assert(__LINE__, s1->size() == len + data.size(), "MyString.read_from(int) should append to the string");
+      for (int skip = 0, i = 0; i < len + data.size() && !skip; ++i) {
+        test_assert(__LINE__, (*s1)[i] == (i < len ? str[i] : data[i - len]), "MyString.read_from(int) should append to the string") || (skip = 1, false);
+      }
+      test_assert(__LINE__, s2->size() == len && (*s2)[len - 1] == str[len - 1], "MyString.read_from(int) should not mutate copies of the string");
+      test_assert(__LINE__, v->size() == 10 && (*v)[0] == str[0], "MyString.read_from(int) should not mutate substrings of the string");
+      delete s1;
+      delete s2;
+      delete v;
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fds[2];
+      test_assert(__LINE__, pipe(fds) == 0, "Cannot create pipe");
+      const std::string data = build_random_string<'\0', 'a', 'b'>(3000);
+      // a child process feeds the pipe in pieces with pauses in between, so
+      // each read() returns only part of the data. a process is used rather
+      // than a thread because the allocation tracer is not thread-safe.
+      pid_t writer = fork();
+      if (writer == 0) {
+        close(fds[0]);
+        for (int i = 0; i < 3; ++i) {
+          usleep(50000);
+          if (write(fds[1], data.data() + i * 1000, 1000) != 1000) _exit(1);
+        }
+        _exit(0);
+      }
+      close(fds[1]);
+      MyString *s = new MyString("");
+      test_assert(__LINE__, s->read_from(fds[0]) == data.size(), "MyString.read_from(int) should read until end of file");
+      int status = 0;
+      waitpid(writer, &status, 0);
+      test_assert(__LINE__, WIFEXITED(status) && WEXITSTATUS(status) == 0, "Cannot write to pipe");
+      test_assert(__LINE__, s->size() == data.size(), "MyString.read_from(int) should update \'.size()\'");
+      for (int skip = 0, i = 0; i < data.size() && !skip; ++i) {
+        test_assert(__LINE__, (*s)[i] == data[i], "MyString.read_from(int) incorrect on a pipe") || (skip = 1, false);
+      }
+      delete s;
+      close(fds[0]);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      MyString *s1 = new MyString(str.get());
+      MyString *s2 = new MyString(*s1);
+      MyString *s3 = new MyString(s1->substr(len / 2, 100));
+      MyString *s4 = new MyString("");
+      MyString *s5 = new MyString("abc");
+      (*s5)[1] = '\0';
+      std::string expected = std::string(str.get()) + str.get() + std::string(str.get() + len / 2, 100) + std::string("a\0c", 3);
+      const MyString *list[] = { s1, s2, s3, s4, s5 };
+      int last_alloc_mem = alloc_mem;
+      test_assert(__LINE__, MyString::write_to(fd, list, 5) == expected.size(), "MyString::write_to(int, const MyString *const *, size_t) should return the number of bytes written");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX, "MyString::write_to(int, const MyString *const *, size_t) should not copy the strings");
+      test_assert(__LINE__, read_file(fd) == expected, "MyString::write_to(int, const MyString *const *, size_t) should write all strings in order");
+      delete s1;
+      delete s2;
+      delete s3;
+      delete s4;
+      delete s5;
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const int count = 3000;
+      MyString *base = new MyString("0123456789");
+      const MyString **list = new const MyString*[count];
+      std::string expected;
+      for (int i = 0; i < count; ++i) {
+        list[i] = new MyString(base->substr(i % 10, i % 7));
+        expected += std::string("0123456789").substr(i % 10, i % 7);
+      }
+      test_assert(__LINE__, MyString::write_to(fd, list, count) == expected.size(), "MyString::write_to(int, const MyString *const *, size_t) incorrect for many strings");
+      test_assert(__LINE__, read_file(fd) == expected, "MyString::write_to(int, const MyString *const *, size_t) incorrect for many strings");
+      for (int i = 0; i < count; ++i) {
+        delete list[i];
+      }
+      delete[] list;
+      delete base;
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const std::string str = build_random_string<'\0', 'a'>(10000);
+      const auto s = build_string<MyString>(str);
+      const MyString &cs = *s;
+      int last_alloc_mem = alloc_mem;
+      test_assert(__LINE__, cs.write_to(fd) == str.size(), "MyString.write_to(int) should return the number of bytes written");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem == 0, "MyString.write_to(int) should not copy the string");
+      test_assert(__LINE__, read_file(fd) == str, "MyString.write_to(int) should write the string with null chars");
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+#endif
+
+#if defined(MYSTRING_HAS_SERIALIZATION) && !defined(_WIN32)
+  printf("===== Testing Serialization =====\n");
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const auto str_1 = build_magic_string();
+      const auto str_2 = build_magic_string();
+      int len_1 = strlen(str_1.get());
+      int len_2 = strlen(str_2.get());
+      MyString *s1 = new MyString(str_1.get());
+      MyString *s2 = new MyString(*s1);
+      MyString *s3 = new MyString(*s1);
+      MyString *s4 = new MyString(*s2);
+      MyString *s5 = new MyString(*s2);
+      MyString *s6 = new MyString(str_2.get());
+      MyString *s7 = new MyString(s6->substr(len_2 / 2, len_2 / 2));
+      const MyString *list[] = { s1, s2, s3, s4, s5, s6, s7 };
+      test_assert(__LINE__, MyString::save(fd, list, 7), "MyString::save(int, const MyString *const *, size_t) should succeed");
+      // s1..s5 share one buffer and s6, s7 share another, so each buffer is stored once.
+      test_assert(__LINE__, file_size(fd) < CLASS_SIZE_MAX * 8 + len_1 + len_2, "MyString::save(int, const MyString *const *, size_t) should store shared buffers once");
+
+      MyString *l[7];
+      for (int i = 0; i < 7; ++i) {
+        l[i] = new MyString;
+      }
+      int last_alloc_mem = alloc_mem;
+      int last_alloc_times = alloc_times;
+      lseek(fd, 0, SEEK_SET);
+      test_assert(__LINE__, MyString::load(fd, l, 7), "MyString::load(int, MyString *const *, size_t) should succeed");
+      // one allocation per shared buffer. s7 must not get a copy of its slice.
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX * 2 + len_1 + len_2, "MyString::load(int, MyString *const *, size_t) should rebuild shared buffers once");
+      test_assert(__LINE__, alloc_times - last_alloc_times <= 2, "MyString::load(int, MyString *const *, size_t) should rebuild shared buffers once");
+      for (int skip = 0, i = 0; i < 7 && !skip; ++i) {
+        test_assert(__LINE__, *l[i] == *list[i], "MyString::load(int, MyString *const *, size_t) should restore every string") || (skip = 1, false);
+      }
+
+      last_alloc_mem = alloc_mem;
+      (*l[1])[0]++;
+      // mutate a loaded copy. only that copy is unshared.
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX + len_1, "Mutating a loaded MyString should only copy that string");
+      test_assert(__LINE__, (*l[1])[0] == str_1[0] + 1, "MyString[size_t] should be mutable after loading");
+      for (int skip = 0, i = 0; i < 7 && !skip; ++i) {
+        if (i == 1) continue;
+        test_assert(__LINE__, *l[i] == *list[i], "Mutating a loaded MyString should not mutate the others") || (skip = 1, false);
+      }
+
+      for (int i = 0; i < 7; ++i) {
+        delete list[i];
+        delete l[i];
+      }
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const std::string str = build_random_string<'\0', 'a', 'b'>(5000);
+      const auto s = build_string<MyString>(str);
+      MyString *s1 = new MyString("");
+      MyString *s2 = new MyString(*s);
+      MyString *s3 = new MyString(s->substr(4000, 1000));
+      const MyString *list[] = { s.get(), s1, s2, s3 };
+      test_assert(__LINE__, MyString::save(fd, list, 4), "MyString::save(int, const MyString *const *, size_t) should succeed");
+
+      MyString *l[4];
+      for (int i = 0; i < 4; ++i) {
+        l[i] = new MyString("placeholder");
+      }
+      lseek(fd, 0, SEEK_SET);
+      test_assert(__LINE__, MyString::load(fd, l, 4), "MyString::load(int, MyString *const *, size_t) should succeed");
+      test_assert(__LINE__, l[0]->size() == str.size() && l[1]->size() == 0 && l[3]->size() == 1000, "MyString::load(int, MyString *const *, size_t) should restore sizes");
+      for (int skip = 0, i = 0; i < str.size() && !skip; ++i) {
+        test_assert(__LINE__, (*l[2])[i] == str[i], "MyString::load(int, MyString *const *, size_t) should keep null chars") || (skip = 1, false);
+      }
+      for (int skip = 0, i = 0; i < 1000 && !skip; ++i) {
+        test_assert(__LINE__, (*l[3])[i] == str[4000 + i], "MyString::load(int, MyString *const *, size_t) should restore substrings") || (skip = 1, false);
+      }
+
+      for (int i = 0; i < 4; ++i) {
+        delete l[i];
+      }
+      delete s1;
+      delete s2;
+      delete s3;
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const auto str = build_magic_string();
+      int len = strlen(str.get());
+      const int count = 1000;
+      MyString *base = new MyString(str.get());
+      const MyString **list = new const MyString*[count];
+      for (int i = 0; i < count; ++i) {
+        list[i] = i % 2 ? new MyString(*base) : new MyString(base->substr(i % len, len / 2));
+      }
+      test_assert(__LINE__, MyString::save(fd, list, count), "MyString::save(int, const MyString *const *, size_t) should succeed");
+      test_assert(__LINE__, file_size(fd) < CLASS_SIZE_MAX * (count + 1) + len, "MyString::save(int, const MyString *const *, size_t) should store shared buffers once");
+
+      MyString **l = new MyString*[count];
+      for (int i = 0; i < count; ++i) {
+        l[i] = new MyString;
+      }
+      int last_alloc_mem = alloc_mem;
+      int last_alloc_times = alloc_times;
+      lseek(fd, 0, SEEK_SET);
+      test_assert(__LINE__, MyString::load(fd, l, count), "MyString::load(int, MyString *const *, size_t) should succeed");
+      test_assert(__LINE__, alloc_mem - last_alloc_mem < CLASS_SIZE_MAX + len, "MyString::load(int, MyString *const *, size_t) should rebuild shared buffers once");
+      test_assert(__LINE__, alloc_times - last_alloc_times <= 1, "MyString::load(int, MyString *const *, size_t) should rebuild shared buffers once");
+      for (int skip = 0, i = 0; i < count && !skip; ++i) {
+        test_assert(__LINE__, *l[i] == *list[i], "MyString::load(int, MyString *const *, size_t) should restore every string") || (skip = 1, false);
+      }
+
+      for (int i = 0; i < count; ++i) {
+        delete list[i];
+        delete l[i];
+      }
+      delete[] list;
+      delete[] l;
+      delete base;
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+
+  run_test([] {
+    {
+      int fd = open_temp_file();
+      const auto str = build_magic_string();
+      MyString *s1 = new MyString(str.get());
+      MyString *s2 = new MyString(*s1);
+      const MyString *list[] = { s1, s2 };
+      MyString *l[3] = { new MyString, new MyString, new MyString };
+      test_assert(__LINE__, MyString::save(fd, list, 0), "MyString::save(int, const MyString *const *, size_t) should succeed for no strings");
+      lseek(fd, 0, SEEK_SET);
+      test_assert(__LINE__, MyString::load(fd, l, 0), "MyString::load(int, MyString *const *, size_t) should succeed for no strings");
+
+      truncate_file(fd);
+      test_assert(__LINE__, MyString::save(fd, list, 2), "MyString::save(int, const MyString *const *, size_t) should succeed");
+      lseek(fd, 0, SEEK_SET);
+      test_assert(__LINE__, !MyString::load(fd, l, 3), "MyString::load(int, MyString *const *, size_t) should fail when the count does not match");
+      lseek(fd, 0, SEEK_SET);
+      test_assert(__LINE__, MyString::load(fd, l, 2), "MyString::load(int, MyString *const *, size_t) should succeed when the count matches");
+
+      truncate_file(fd, file_size(fd) / 2);
+      test_assert(__LINE__, !MyString::load(fd, l, 2), "MyString::load(int, MyString *const *, size_t) should fail on a truncated file");
+
+      // write_file() truncates and rewinds, so the file holds only the text.
+      write_file(fd, std::string(str.get()));
+      test_assert(__LINE__, file_size(fd) == strlen(str.get()), "Cannot write temporary file");
+      test_assert(__LINE__, !MyString::load(fd, l, 2), "MyString::load(int, MyString *const *, size_t) should fail on a file it did not save");
+
+      delete s1;
+      delete s2;
+      for (int i = 0; i < 3; ++i) {
+        delete l[i];
+      }
+      close(fd);
+    }
+    test_assert(__LINE__, alloc_mem == 0, "MyString should free all allocated memory");
+  });
+#endif
+
   alloc_trace_enabled = false;
   return 0;
 }
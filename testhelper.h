@@ -6,6 +6,15 @@
 #include <functional>
 #include <memory>
 #include <map>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
 
 const int MAGIC_BUFFER_SIZE = 1000;
 
@@ -77,6 +86,211 @@ namespace test_helper {
     return stat;
   }
 
+  // Every string of length 0..MAX_LEN over ALPHABET, shortest first.
+  template <int MAX_LEN, char... ALPHABET>
+  std::vector<std::string> enumerate_strings() {
+    const char alphabet[] = { ALPHABET... };
+    std::vector<std::string> ret(1);
+    for (std::size_t begin = 0, len = 0; len < static_cast<std::size_t>(MAX_LEN); ++len) {
+      std::size_t end = ret.size();
+      for (std::size_t i = begin; i < end; ++i) {
+        for (char c : alphabet) {
+          ret.push_back(ret[i] + c);
+        }
+      }
+      begin = end;
+    }
+    return ret;
+  }
+
+  // Random string of exactly `len` chars drawn from ALPHABET, which may contain '\0'.
+  template <char... ALPHABET>
+  std::string build_random_string(std::size_t len) {
+    const char alphabet[] = { ALPHABET... };
+    std::string ret(len, '\0');
+    for (std::size_t i = 0; i < len; ++i) {
+      ret[i] = alphabet[std::rand() % sizeof(alphabet)];
+    }
+    return ret;
+  }
+
+  // Non-overlapping occurrences of `needle` in `haystack`, scanning from the left.
+  // An empty needle matches at every position, including the end.
+  std::size_t count_occurrences(const std::string &haystack, const std::string &needle) {
+    if (needle.empty()) return haystack.size() + 1;
+    std::size_t ret = 0;
+    for (std::size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + needle.size())) {
+      ret++;
+    }
+    return ret;
+  }
+
+#ifndef _WIN32
+  // Empty temporary file. It is unlinked right away, so it disappears on close().
+  int open_temp_file() {
+    char path[] = "/tmp/mystring_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+      std::printf("*** Cannot create temporary file ***\n");
+      std::exit(1);
+    }
+    unlink(path);
+    return fd;
+  }
+
+  // Cuts `fd` down to its first `size` bytes and rewinds it.
+  void truncate_file(int fd, std::size_t size = 0) {
+    if (ftruncate(fd, size) != 0) {
+      std::printf("*** Cannot truncate temporary file ***\n");
+      std::exit(1);
+    }
+    lseek(fd, 0, SEEK_SET);
+  }
+
+  // Replaces the contents of `fd` with `data` and rewinds it.
+  void write_file(int fd, const std::string &data) {
+    truncate_file(fd);
+    for (std::size_t done = 0; done < data.size(); ) {
+      ssize_t ret = write(fd, data.data() + done, data.size() - done);
+      if (ret <= 0) {
+        std::printf("*** Cannot write temporary file ***\n");
+        std::exit(1);
+      }
+      done += ret;
+    }
+    lseek(fd, 0, SEEK_SET);
+  }
+
+  // Size of the file behind `fd`, without moving its offset.
+  std::size_t file_size(int fd) {
+    struct stat st;
+    fstat(fd, &st);
+    return st.st_size;
+  }
+
+  // Reads everything in `fd` from the start.
+  std::string read_file(int fd) {
+    std::string ret;
+    char buffer[4096];
+    lseek(fd, 0, SEEK_SET);
+    for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0; ) {
+      ret.append(buffer, n);
+    }
+    return ret;
+  }
+#endif
+
+  // Builds a String holding `src`, poking embedded '\0' in through operator[].
+  template <typename String>
+  std::unique_ptr<String> build_string(const std::string &src) {
+    std::string placeholder(src);
+    for (char &c : placeholder) {
+      if (c == '\0') c = '?';
+    }
+    auto ret = std::unique_ptr<String>(new String(placeholder.c_str()));
+    for (std::size_t i = 0; i < src.size(); ++i) {
+      if (src[i] == '\0') (*ret)[i] = '\0';
+    }
+    return ret;
+  }
+
+  std::string escape_string(const std::string &src) {
+    std::string ret;
+    for (char c : src) {
+      if (c == '\0') {
+        ret += "\\0";
+      } else {
+        ret += c;
+      }
+    }
+    return ret;
+  }
+
+  template <typename String>
+  bool check_comparisons(String &s1, String &s2, int ref) {
+    return (s1 == s2) == (ref == 0) && (s1 != s2) == (ref != 0)
+        && (s1 <  s2) == (ref <  0) && (s1 <= s2) == (ref <= 0)
+        && (s1 >  s2) == (ref >  0) && (s1 >= s2) == (ref >= 0);
+  }
+
+  struct comparison_chunk {
+    long long pairs = 0;
+    long long failures = 0;
+    std::size_t first_i = 0;
+    std::size_t first_j = 0;
+  };
+
+  // Checks all six comparison operators on every pair of strings of length
+  // 0..MAX_LEN over ALPHABET against std::string ordering. Rows are split into
+  // `num_chunks` interleaved chunks; with more than one chunk each runs on its
+  // own thread with its own copies of the strings, and allocation tracing is
+  // paused because the tracer is not thread-safe. Pass 0 to use every core.
+  template <typename String, int MAX_LEN, char... ALPHABET>
+  void test_all_comparisons(int line_no, unsigned num_chunks) {
+    const auto strs = enumerate_strings<MAX_LEN, ALPHABET...>();
+    if (num_chunks == 0) {
+      num_chunks = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<comparison_chunk> chunks(num_chunks);
+
+    const auto run_chunk = [&strs, num_chunks](unsigned chunk_id, comparison_chunk &result) {
+      std::vector<std::unique_ptr<String>> built;
+      for (const auto &str : strs) {
+        built.push_back(build_string<String>(str));
+      }
+      for (std::size_t i = chunk_id; i < strs.size(); i += num_chunks) {
+        for (std::size_t j = 0; j < strs.size(); ++j) {
+          int ref = strs[i].compare(strs[j]);
+          if (!check_comparisons(*built[i], *built[j], ref) && result.failures++ == 0) {
+            result.first_i = i;
+            result.first_j = j;
+          }
+          result.pairs++;
+        }
+      }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    if (num_chunks == 1) {
+      run_chunk(0, chunks[0]);
+    } else {
+      const bool trace_was_enabled = alloc_trace_enabled;
+      alloc_trace_enabled = false;
+      {
+        std::vector<std::thread> workers;
+        for (unsigned c = 0; c < num_chunks; ++c) {
+          workers.emplace_back(run_chunk, c, std::ref(chunks[c]));
+        }
+        for (auto &worker : workers) {
+          worker.join();
+        }
+      }
+      alloc_trace_enabled = trace_was_enabled;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    long long pairs = 0;
+    for (const auto &chunk : chunks) {
+      pairs += chunk.pairs;
+      if (chunk.failures == 0) continue;
+      const std::string &str_1 = strs[chunk.first_i];
+      const std::string &str_2 = strs[chunk.first_j];
+      printf("Comparison failed for \"%s\" and \"%s\" (%lld failing pairs in chunk)\n",
+          escape_string(str_1).c_str(), escape_string(str_2).c_str(), chunk.failures);
+      auto s1 = build_string<String>(str_1);
+      auto s2 = build_string<String>(str_2);
+      int ref = str_1.compare(str_2);
+      test_assert(line_no, (*s1 == *s2) == (ref == 0), "MyString.operator== incorrect");
+      test_assert(line_no, (*s1 >= *s2) == (ref >= 0), "MyString.operator>= incorrect");
+      test_assert(line_no, (*s1 <= *s2) == (ref <= 0), "MyString.operator<= incorrect");
+      test_assert(line_no, (*s1 != *s2) == (ref != 0), "MyString.operator!= incorrect");
+      test_assert(line_no, (*s1 >  *s2) == (ref >  0), "MyString.operator> incorrect");
+      test_assert(line_no, (*s1 <  *s2) == (ref <  0), "MyString.operator< incorrect");
+    }
+    printf("%lld pairs (%lld comparisons) in %.3fs, %.1fM comparisons/s\n",
+        pairs, pairs * 6, elapsed.count(), pairs * 6 / elapsed.count() / 1e6);
+  }
+
 }
 
 void* operator new(std::size_t sz) {